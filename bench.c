@@ -0,0 +1,253 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "structs.h"
+#include "sim.h"
+
+#define QUEUE_OPS 100000
+#define QUEUE_BATCH 1000
+#define BOARD_OPS_PER_THREAD 20000
+#define MAX_THREADS 8
+#define COUNT_OPS 1000000
+
+// Function declarations
+void setup();
+void bench_queue(int units);
+void fill_line(Queue* line, Vehicle* v, int count);
+void bench_board(int threads);
+void* board_thread(void* arg);
+void bench_departure();
+void bench_departure_check(const char* name, int head_type);
+void report(const char* name, int threads, int units, long long ops, long long elapsed);
+long long now_ns();
+
+// Results are written here as CSV, stdout itself is silenced since the simulation prints updates.
+FILE* results;
+pthread_barrier_t board_barrier;
+// Keeps the compiler from dropping the measured calls.
+volatile int sink;
+
+int main() {
+    results = fdopen(dup(STDOUT_FILENO), "w");
+    if (results == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "ERROR: Could not redirect output.\n");
+        exit(1);
+    }
+    fprintf(results, "benchmark,threads,line_units,ops,ns_per_op\n");
+    setup();
+    // Queue operations, from a single vehicle up to lines way over the 20 unit limit.
+    int units[] = {1, 5, 20, 100, 1000};
+    for (int i = 0; i < 5; i++) {
+        bench_queue(units[i]);
+    }
+    // Boarding critical section under 1 to MAX_THREADS contending vehicles.
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        bench_board(threads);
+    }
+    // Ferry departure check.
+    bench_departure();
+    fclose(results);
+    return 0;
+}
+
+void setup() {
+    // Same shape as main.c, but everything is in Port 0 with Ferry0 docked there.
+    pthread_mutex_init(&print_lock, NULL);
+    for (int i = 0; i < 2; i++) {
+        ports[i].id = i;
+        for (int j = 0; j < 3; j++) {
+            ports[i].waiting_lines[j].head = NULL;
+        }
+        pthread_mutex_init(&ports[i].waiting_line_lock, NULL);
+        ports[i].current_line = 0;
+        ferries[i] = malloc(sizeof(Ferry));
+        ferries[i]->id = i;
+        ferries[i]->port_id = 0;
+        ferries[i]->docked = 1;
+        ferries[i]->ready_to_load = 1;
+        ferries[i]->loading_line.head = NULL;
+        pthread_mutex_init(&ferries[i]->ferry_lock, NULL);
+        pthread_mutex_init(&ferries[i]->waiting_lock, NULL);
+    }
+    // Vehicles have all passed the booths, so none of them hold back the departure check.
+    for (int i = 0; i < NUM_VEHICLES; i++) {
+        vehicles[i] = malloc(sizeof(Vehicle));
+        vehicles[i]->id = i;
+        vehicles[i]->type = 1;
+        vehicles[i]->special = 0;
+        vehicles[i]->port_id = 0;
+        vehicles[i]->booth_id = 0;
+        vehicle_threads_completed[i] = 0;
+    }
+}
+
+void bench_queue(int units) {
+    // Fill the line with motorcycles, so units and vehicles are the same.
+    Queue line;
+    line.head = NULL;
+    Vehicle v = {0, 1, 0, 0, 0};
+    fill_line(&line, &v, units);
+    // dequeue does not free the nodes, keep them here and free them outside the measurement.
+    Node** removed = malloc(QUEUE_OPS * sizeof(Node*));
+    // Enqueue followed by dequeue, so the line stays at the given length.
+    // enqueue walks the whole line, so it can not be timed alone without the line growing.
+    long long start = now_ns();
+    for (int i = 0; i < QUEUE_OPS; i++) {
+        enqueue(&line, &v);
+        removed[i] = line.head;
+        dequeue(&line);
+    }
+    long long pair_time = now_ns() - start;
+    for (int i = 0; i < QUEUE_OPS; i++) {
+        free(removed[i]);
+    }
+    // Dequeue alone, the line is refilled by QUEUE_BATCH outside the measurement and every batch
+    // dequeues back down to the given length.
+    long long dequeue_time = 0;
+    for (int batch = 0; batch < QUEUE_OPS / QUEUE_BATCH; batch++) {
+        fill_line(&line, &v, QUEUE_BATCH);
+        start = now_ns();
+        for (int i = batch * QUEUE_BATCH; i < (batch + 1) * QUEUE_BATCH; i++) {
+            removed[i] = line.head;
+            dequeue(&line);
+        }
+        dequeue_time += now_ns() - start;
+    }
+    for (int i = 0; i < QUEUE_OPS; i++) {
+        free(removed[i]);
+    }
+    free(removed);
+    // enqueue is estimated as the pair minus a dequeue, clamped since both timings are noisy.
+    long long enqueue_time = pair_time - dequeue_time;
+    if (enqueue_time < 0) {
+        enqueue_time = 0;
+    }
+    report("enqueue_dequeue", 1, units, QUEUE_OPS, pair_time);
+    report("enqueue", 1, units, QUEUE_OPS, enqueue_time);
+    report("dequeue", 1, units, QUEUE_OPS, dequeue_time);
+    start = now_ns();
+    for (int i = 0; i < QUEUE_OPS; i++) {
+        sink = length(&line);
+    }
+    report("length", 1, units, QUEUE_OPS, now_ns() - start);
+    while (line.head != NULL) {
+        Node* head = line.head;
+        dequeue(&line);
+        free(head);
+    }
+}
+
+void fill_line(Queue* line, Vehicle* v, int count) {
+    // Same as calling enqueue count times, without walking the whole line for every vehicle.
+    Node** tail = &line->head;
+    while (*tail != NULL) {
+        tail = &(*tail)->next;
+    }
+    for (int i = 0; i < count; i++) {
+        *tail = (Node*)malloc(sizeof(Node));
+        (*tail)->data = v;
+        (*tail)->next = NULL;
+        tail = &(*tail)->next;
+    }
+}
+
+void bench_board(int threads) {
+    pthread_t board_threads[MAX_THREADS];
+    pthread_barrier_init(&board_barrier, NULL, threads + 1);
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&board_threads[i], NULL, board_thread, vehicles[i]);
+    }
+    // Start the clock once every thread is ready to contend.
+    pthread_barrier_wait(&board_barrier);
+    long long start = now_ns();
+    for (int i = 0; i < threads; i++) {
+        pthread_join(board_threads[i], NULL);
+    }
+    long long elapsed = now_ns() - start;
+    pthread_barrier_destroy(&board_barrier);
+    report("board_ferry", threads, 0, (long long)threads * BOARD_OPS_PER_THREAD, elapsed);
+}
+
+void* board_thread(void* arg) {
+    // Grab vehicle pointer from parameter.
+    Vehicle* v = (Vehicle*)arg;
+    Ferry* f = ferries[0];
+    Port* p = &ports[v->port_id];
+    pthread_barrier_wait(&board_barrier);
+    for (int i = 0; i < BOARD_OPS_PER_THREAD; i++) {
+        // Same lock sequence as vehicle_thread in main.c.
+        pthread_mutex_lock(&f->ferry_lock);
+        pthread_mutex_lock(&p->waiting_line_lock);
+        pthread_mutex_lock(&f->waiting_lock);
+        // Step into the current line, board the head vehicle and unload it right away so the ferry stays empty.
+        enqueue(&p->waiting_lines[p->current_line], v);
+        Node* waiting = p->waiting_lines[p->current_line].head;
+        sink = board_ferry(f, v);
+        Node* loaded = f->loading_line.head;
+        dequeue(&f->loading_line);
+        pthread_mutex_unlock(&f->waiting_lock);
+        pthread_mutex_unlock(&p->waiting_line_lock);
+        pthread_mutex_unlock(&f->ferry_lock);
+        free(waiting);
+        free(loaded);
+    }
+    pthread_exit(NULL);
+}
+
+void bench_departure() {
+    // available_vehicle_left sleeps 100 ms for every line it looks at, so only first_fitting_line is measured here.
+    // A motorcycle fits, the ferry departs once no line has one that does.
+    bench_departure_check("first_fitting_line", 1);
+    // Trucks do not fit into the almost full ferry, so every line is checked.
+    bench_departure_check("first_fitting_line_full", 4);
+    long long start = now_ns();
+    for (int i = 0; i < COUNT_OPS; i++) {
+        sink = get_total_vehicles_in_port(0);
+    }
+    report("get_total_vehicles_in_port", 1, 0, COUNT_OPS, now_ns() - start);
+}
+
+void bench_departure_check(const char* name, int head_type) {
+    Ferry* f = ferries[0];
+    Vehicle head = {0, head_type, 0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        enqueue(&ports[0].waiting_lines[i], &head);
+    }
+    // Load the ferry with 29 units if the heads should not fit.
+    Vehicle loaded = {1, 1, 0, 0, 0};
+    int loaded_units = (head_type == 1) ? 0 : 29;
+    for (int i = 0; i < loaded_units; i++) {
+        enqueue(&f->loading_line, &loaded);
+    }
+    long long start = now_ns();
+    for (int i = 0; i < COUNT_OPS; i++) {
+        sink = first_fitting_line(f);
+    }
+    report(name, 1, 0, COUNT_OPS, now_ns() - start);
+    for (int i = 0; i < 3; i++) {
+        Node* node = ports[0].waiting_lines[i].head;
+        dequeue(&ports[0].waiting_lines[i]);
+        free(node);
+    }
+    while (f->loading_line.head != NULL) {
+        Node* node = f->loading_line.head;
+        dequeue(&f->loading_line);
+        free(node);
+    }
+}
+
+void report(const char* name, int threads, int units, long long ops, long long elapsed) {
+    double ns_per_op = (double)elapsed / ops;
+    fprintf(stderr, "%-28s threads=%-2d units=%-5d %14.1f ns/op\n", name, threads, units, ns_per_op);
+    fprintf(results, "%s,%d,%d,%lld,%.1f\n", name, threads, units, ops, ns_per_op);
+}
+
+long long now_ns() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
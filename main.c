@@ -4,33 +4,31 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <string.h>
 #include <time.h>
 #include "structs.h"
-
-#define NUM_VEHICLES 32
+#include "sim.h"
 
 // Shared resources
 Port ports[2];
 Vehicle* vehicles[NUM_VEHICLES];
 Ferry* ferries[2];
 pthread_mutex_t print_lock;
+// Sharded mode, vehicles and ferries go through the state each port publishes instead of scanning both ports.
+int sharded_mode = 0;
 // Threads
 int vehicle_threads_completed[NUM_VEHICLES];
 int vehicle_start_ports[NUM_VEHICLES];
 int vehicle_end_ports[NUM_VEHICLES];
 pthread_t vehicle_threads[NUM_VEHICLES];
 pthread_t ferry_threads[2];
-// Function declarations
-int get_total_vehicles_in_port(int port_id);
-int vehicle_left_in_booths(int port_id);
-int ferry_in_port(int port_id);
-int available_vehicle_left(Ferry* f);
-int board_ferry(Ferry* f, Vehicle* v);
-void* ferry_thread(void* arg);
-void* vehicle_thread(void* arg);
-void msleep(int ms);
 
-int main() {
+// The benchmarks in bench.c bring their own main.
+#ifndef BENCH
+int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--sharded") == 0) {
+        sharded_mode = 1;
+    }
     // Set seed for rng.
     srand(time(NULL) % 306);
     printf("INFO: Initialization begun.\n");
@@ -38,6 +36,9 @@ int main() {
     // Create 2 Ports.
     for (int i = 0; i < 2; i++) {
         ports[i].id = i;
+        atomic_init(&ports[i].docked_ferry, NULL);
+        atomic_init(&ports[i].vehicle_count, 0);
+        pthread_cond_init(&ports[i].ferry_docked, NULL);
         printf("INFO: Created new port with id %d.\n", ports[i].id);
         // Create 4 Booths.
         for (int j = 0; j < 4; j++) {
@@ -77,6 +78,7 @@ int main() {
             exit(1);
         }
         new_queue(&ferries[i]->loading_line);
+        ports[i].docked_ferry = ferries[i];
         printf("INFO: Created new ferry with id %d in port %d.\n", ferries[i]->id, ports[i].id);
     }
     // Create NUM_VEHICLES Vehicles. (Default: 32)
@@ -87,6 +89,7 @@ int main() {
         vehicles[i]->port_id = rand() % 2;
         vehicles[i]->booth_id = -1;
         vehicle_start_ports[i] = vehicles[i]->port_id;
+        atomic_fetch_add(&ports[vehicles[i]->port_id].vehicle_count, 1);
         // Assign type (unit) based on vehicle id.
         if (i < 8) {
             vehicles[i]->type = 1; // Motorcycle
@@ -100,6 +103,9 @@ int main() {
     }
     printf("INFO: Initialization done.\n");
     printf("INFO: Creating threads.\n");
+    if (sharded_mode) {
+        printf("INFO: Running in sharded mode.\n");
+    }
     // Create 2 Ferry threads with ferry_thread func and assign Ferry data from ferries[] array.
     for (int i = 0; i < 2; i++) {
         pthread_create(&ferry_threads[i], NULL, ferry_thread, ferries[i]);
@@ -134,6 +140,7 @@ int main() {
     }
     return 0;
 }
+#endif
 
 void* ferry_thread(void* arg) {
     // Grab ferry pointer from parameter.
@@ -169,11 +176,20 @@ void* ferry_thread(void* arg) {
             // Lock the ferry and waiting lines.
             pthread_mutex_lock(&f->ferry_lock);
             pthread_mutex_lock(&ports[f->port_id].waiting_line_lock);
+            // A ferry that arrived while another one was docked takes over the port once it is free.
+            if (sharded_mode) {
+                dock_ferry(f);
+            }
             // Check if ferry is full OR there are no more vehicles that ferry can pick up AND ferry is not empty.
             // OR check if current port has no vehicles AND target port has vehicles AND target port has no ferries. This is in order to rescue trapped vehicles in a port.
-            if (((length(&f->loading_line) == 30 || !available_vehicle_left(f)) && length(&f->loading_line) != 0) ||
-                ((get_total_vehicles_in_port(f->port_id) == 0 && get_total_vehicles_in_port((f->port_id == 0) ? 1 : 0) != 0) && (!ferry_in_port((f->port_id == 0) ? 1 : 0)))) {
-                // We can move to the other port.
+            // In sharded mode, only the ferry docked by the port can leave, the others are still waiting for it to leave.
+            if ((!sharded_mode || ports[f->port_id].docked_ferry == f) &&
+                (((length(&f->loading_line) == 30 || !available_vehicle_left(f)) && length(&f->loading_line) != 0) ||
+                ((get_total_vehicles_in_port(f->port_id) == 0 && get_total_vehicles_in_port((f->port_id == 0) ? 1 : 0) != 0) && (!ferry_in_port((f->port_id == 0) ? 1 : 0))))) {
+                // We can move to the other port, free the port for the next ferry.
+                if (sharded_mode) {
+                    atomic_store(&ports[f->port_id].docked_ferry, NULL);
+                }
                 pthread_mutex_unlock(&ports[f->port_id].waiting_line_lock);
                 pthread_mutex_lock(&print_lock);
                 printf("UPDATE: Ferry%d is moving to Port %d.\n", f->id, (f->port_id == 0) ? 1 : 0);
@@ -196,6 +212,8 @@ void* ferry_thread(void* arg) {
                 // Change port id of every vehicle inside the ferry loading line.
                 Node* current = f->loading_line.head;
                 while (current != NULL) {
+                    atomic_fetch_sub(&ports[current->data->port_id].vehicle_count, 1);
+                    atomic_fetch_add(&ports[f->port_id].vehicle_count, 1);
                     current->data->port_id = f->port_id;
                     current = current->next;
                 }
@@ -205,6 +223,12 @@ void* ferry_thread(void* arg) {
                 pthread_mutex_unlock(&print_lock);
                 f->docked = 1;
                 f->ready_for_round_trip = 1;
+                // Dock at the new port, unless another ferry is still docked there.
+                if (sharded_mode) {
+                    pthread_mutex_lock(&ports[f->port_id].waiting_line_lock);
+                    dock_ferry(f);
+                    pthread_mutex_unlock(&ports[f->port_id].waiting_line_lock);
+                }
                 pthread_mutex_unlock(&f->ferry_lock);
                 break;
             }
@@ -271,27 +295,13 @@ void* vehicle_thread(void* arg) {
     // Try to board the ferry.
     while (1) {
         msleep(100);
-        int select = 0;
-        while (!select) {
-            // Check all ferries: if the ferry port id is the same as vehicle port id
-            // AND the ferry is docked, that's the ferry vehicle is going to board.
-            for (int f = 0; f < 2; f++) {
-                pthread_mutex_lock(&ferries[f]->ferry_lock);
-                if (ferries[f]->port_id == v->port_id && ferries[f]->docked) {
-                    ferry_id = f;
-                    pthread_mutex_unlock(&ferries[f]->ferry_lock);
-                    select = 1;
-                    break;
-                }
-                pthread_mutex_unlock(&ferries[f]->ferry_lock);
-            }
-        }
+        ferry_id = select_ferry(v);
         Node* current = ports[v->port_id].waiting_lines[ports[v->port_id].current_line].head;
         pthread_mutex_lock(&ferries[ferry_id]->ferry_lock);
         pthread_mutex_lock(&ports[v->port_id].waiting_line_lock);
         pthread_mutex_lock(&ferries[ferry_id]->waiting_lock);
         // Check the current line's head vehicle and try to board it to the ferry
-        if (current != NULL && ferries[ferry_id]->docked && current->data->id == v->id && ferries[ferry_id]->ready_to_load) {
+        if (current != NULL && ferries[ferry_id]->docked && ferries[ferry_id]->port_id == v->port_id && current->data->id == v->id && ferries[ferry_id]->ready_to_load) {
             int boarded = board_ferry(ferries[ferry_id], v);
             pthread_mutex_unlock(&ferries[ferry_id]->waiting_lock);
             // Vehicle could not board due to space, go to next line in a circular manner.
@@ -380,27 +390,13 @@ void* vehicle_thread(void* arg) {
     // Try to board the ferry.
     while (1) {
         msleep(100);
-        int select = 0;
-        while (!select) {
-            // Check all ferries: if the ferry port id is the same as vehicle port id
-            // AND the ferry is docked, that's the ferry vehicle is going to board.
-            for (int f = 0; f < 2; f++) {
-                pthread_mutex_lock(&ferries[f]->ferry_lock);
-                if (ferries[f]->port_id == v->port_id && ferries[f]->docked) {
-                    ferry_id = f;
-                    pthread_mutex_unlock(&ferries[f]->ferry_lock);
-                    select = 1;
-                    break;
-                }
-                pthread_mutex_unlock(&ferries[f]->ferry_lock);
-            }
-        }
+        ferry_id = select_ferry(v);
         Node* current = ports[v->port_id].waiting_lines[ports[v->port_id].current_line].head;
         pthread_mutex_lock(&ferries[ferry_id]->ferry_lock);
         pthread_mutex_lock(&ports[v->port_id].waiting_line_lock);
         pthread_mutex_lock(&ferries[ferry_id]->waiting_lock);
         // Check the current line's head vehicle and try to board it to the ferry
-        if (current != NULL && ferries[ferry_id]->docked && current->data->id == v->id && ferries[ferry_id]->ready_to_load) {
+        if (current != NULL && ferries[ferry_id]->docked && ferries[ferry_id]->port_id == v->port_id && current->data->id == v->id && ferries[ferry_id]->ready_to_load) {
             int boarded = board_ferry(ferries[ferry_id], v);
             pthread_mutex_unlock(&ferries[ferry_id]->waiting_lock);
             // Vehicle could not board due to space, go to next line in a circular manner.
@@ -453,6 +449,7 @@ void* vehicle_thread(void* arg) {
         pthread_mutex_unlock(&ferries[ferry_id]->waiting_lock);
         pthread_mutex_unlock(&ferries[ferry_id]->ferry_lock);
     }
+    atomic_fetch_sub(&ports[v->port_id].vehicle_count, 1);
     vehicle_threads_completed[v->id] = 1;
     vehicle_end_ports[v->id] = v->port_id;
     pthread_exit(NULL);
@@ -472,19 +469,70 @@ int board_ferry(Ferry* f, Vehicle* v) {
     return 0;
 }
 
+int select_ferry(Vehicle* v) {
+    while (1) {
+        if (sharded_mode) {
+            // The port knows which ferry is docked, no need to look at ferries of the other port.
+            // Sleep until a ferry docks if the port is empty.
+            pthread_mutex_lock(&ports[v->port_id].waiting_line_lock);
+            while (atomic_load(&ports[v->port_id].docked_ferry) == NULL) {
+                pthread_cond_wait(&ports[v->port_id].ferry_docked, &ports[v->port_id].waiting_line_lock);
+            }
+            int docked = atomic_load(&ports[v->port_id].docked_ferry)->id;
+            pthread_mutex_unlock(&ports[v->port_id].waiting_line_lock);
+            return docked;
+        }
+        // Check all ferries: if the ferry port id is the same as vehicle port id
+        // AND the ferry is docked, that's the ferry vehicle is going to board.
+        for (int f = 0; f < 2; f++) {
+            pthread_mutex_lock(&ferries[f]->ferry_lock);
+            if (ferries[f]->port_id == v->port_id && ferries[f]->docked) {
+                pthread_mutex_unlock(&ferries[f]->ferry_lock);
+                return f;
+            }
+            pthread_mutex_unlock(&ferries[f]->ferry_lock);
+        }
+    }
+}
+
+void dock_ferry(Ferry* f) {
+    // Dock the ferry at its port unless another one is already docked there, waiting_line_lock must be held.
+    if (atomic_load(&ports[f->port_id].docked_ferry) == NULL) {
+        atomic_store(&ports[f->port_id].docked_ferry, f);
+        pthread_cond_broadcast(&ports[f->port_id].ferry_docked);
+    }
+}
+
 int available_vehicle_left(Ferry* f) {
     // Check every waiting line to see if there are any vehicle in them or not.
+    // The lines are locked by the caller, so the check is done once and paced with 100 ms for every line looked at.
+    int line = first_fitting_line(f);
+    msleep(100 * ((line == -1) ? 3 : line + 1));
+    return line != -1;
+}
+
+int first_fitting_line(Ferry* f) {
+    // Find the first waiting line with a head vehicle that fits into the ferry, -1 if there is none.
     for (int i = 0; i < 3; i++) {
-        msleep(100);
-        if (ports[f->port_id].waiting_lines[i].head != NULL && ports[f->port_id].waiting_lines[i].head->data->type <= 30 - length(&f->loading_line) && !vehicle_left_in_booths(f->port_id)) {
-            return 1;
+        if (vehicle_fits_from_line(f, i)) {
+            return i;
         }
     }
-    return 0;
+    return -1;
+}
+
+int vehicle_fits_from_line(Ferry* f, int line) {
+    // Check if the head vehicle of a waiting line fits into the ferry and no vehicle is left in the booths.
+    Queue* waiting_line = &ports[f->port_id].waiting_lines[line];
+    return waiting_line->head != NULL && waiting_line->head->data->type <= 30 - length(&f->loading_line) && !vehicle_left_in_booths(f->port_id);
 }
 
 int get_total_vehicles_in_port(int port_id) {
     // Count the total amount of vehicles inside a specified port.
+    // In sharded mode the port keeps the count itself, so there is no need to scan every vehicle.
+    if (sharded_mode) {
+        return atomic_load(&ports[port_id].vehicle_count);
+    }
     int sum = 0;
     for (int i = 0; i < NUM_VEHICLES; i++) {
         if (vehicles[i]->port_id == port_id && vehicle_threads_completed[i] == 0) {
@@ -506,6 +554,9 @@ int vehicle_left_in_booths(int port_id) {
 
 int ferry_in_port(int port_id) {
     // Check if there is any ferry in a specified port.
+    if (sharded_mode) {
+        return atomic_load(&ports[port_id].docked_ferry) != NULL;
+    }
     for (int i = 0; i < 2; i++) {
         if (ferries[i]->port_id == port_id && ferries[i]->docked) {
             return 1;
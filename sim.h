@@ -0,0 +1,31 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <pthread.h>
+#include "structs.h"
+
+#define NUM_VEHICLES 32
+
+// Shared resources, defined in main.c.
+extern Port ports[2];
+extern Vehicle* vehicles[NUM_VEHICLES];
+extern Ferry* ferries[2];
+extern pthread_mutex_t print_lock;
+extern int sharded_mode;
+extern int vehicle_threads_completed[NUM_VEHICLES];
+
+// Function declarations for the simulation.
+int get_total_vehicles_in_port(int port_id);
+int vehicle_left_in_booths(int port_id);
+int ferry_in_port(int port_id);
+int available_vehicle_left(Ferry* f);
+int first_fitting_line(Ferry* f);
+int vehicle_fits_from_line(Ferry* f, int line);
+int board_ferry(Ferry* f, Vehicle* v);
+int select_ferry(Vehicle* v);
+void dock_ferry(Ferry* f);
+void* ferry_thread(void* arg);
+void* vehicle_thread(void* arg);
+void msleep(int ms);
+
+#endif
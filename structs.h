@@ -2,6 +2,10 @@
 #define STRUCTS_H
 
 #include <pthread.h>
+#include <stdatomic.h>
+
+// Size of a cache line, used to keep data owned by different threads on separate lines.
+#define CACHE_LINE_SIZE 64
 
 // Vehicle implementation in a struct.
 typedef struct {
@@ -44,13 +48,16 @@ typedef struct {
     pthread_mutex_t waiting_lock;
 } Ferry;
 
-// Port implementation in a struct.
+// Port implementation in a struct, aligned so ports[0] and ports[1] never share a cache line.
 typedef struct {
-    int id;
+    _Alignas(CACHE_LINE_SIZE) int id;
     Booth booths[4];
     Queue waiting_lines[3];
     pthread_mutex_t waiting_line_lock;
     int current_line;
+    _Atomic(Ferry*) docked_ferry; // ferry vehicles board in sharded mode, written under waiting_line_lock
+    pthread_cond_t ferry_docked; // signalled when a ferry docks
+    atomic_int vehicle_count; // vehicles in the port that have not finished their round trip
 } Port;
 
 // Function declarations for queue system.